@@ -0,0 +1,144 @@
+#ifndef ALLOCATION_COUNTER_H
+#define ALLOCATION_COUNTER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+// Counts the heap allocations made by the search, to check that the search runs without
+// allocating once it has started. Build with -DCOUNT_ALLOCATIONS to turn it on - otherwise
+// nothing is counted and operator new and operator delete are left alone. Such a build checks a
+// small search up front when run with --check-allocations.
+
+// Number of heap allocations made while a CountAllocations guard was alive
+std::atomic<size_t> search_allocations{0};
+// Set on a thread while it should count its allocations
+thread_local bool counting_allocations = false;
+
+// Counts the calling thread's heap allocations while in scope
+class CountAllocations {
+public:
+    CountAllocations() : was_counting(counting_allocations) {
+        counting_allocations = true;
+    }
+
+    ~CountAllocations() {
+        counting_allocations = was_counting;
+    }
+
+private:
+    bool was_counting;
+};
+
+#ifdef COUNT_ALLOCATIONS
+// Every replaceable operator new and operator delete is replaced, so that all of the search's heap
+// allocations are counted and each kind of allocation is freed the way it was made.
+
+// Allocate size bytes with the given alignment, counting the allocation if the calling thread is
+// counting. Returns nullptr if out of memory.
+inline void *counted_allocate(std::size_t size, std::size_t alignment) noexcept {
+    if (counting_allocations) {
+        search_allocations.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (size == 0) {
+        size = 1;
+    }
+    if (alignment <= alignof(std::max_align_t)) {
+        return std::malloc(size);
+    }
+    // aligned_alloc needs the size to be a multiple of the alignment
+    return std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+}
+
+// Allocate as counted_allocate does, throwing if out of memory
+inline void *counted_allocate_or_throw(std::size_t size, std::size_t alignment) {
+    if (void *ptr = counted_allocate(size, alignment)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void *operator new(std::size_t size) {
+    return counted_allocate_or_throw(size, alignof(std::max_align_t));
+}
+
+void *operator new[](std::size_t size) {
+    return counted_allocate_or_throw(size, alignof(std::max_align_t));
+}
+
+void *operator new(std::size_t size, std::align_val_t alignment) {
+    return counted_allocate_or_throw(size, static_cast<std::size_t>(alignment));
+}
+
+void *operator new[](std::size_t size, std::align_val_t alignment) {
+    return counted_allocate_or_throw(size, static_cast<std::size_t>(alignment));
+}
+
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept {
+    return counted_allocate(size, alignof(std::max_align_t));
+}
+
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept {
+    return counted_allocate(size, alignof(std::max_align_t));
+}
+
+void *operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t &) noexcept {
+    return counted_allocate(size, static_cast<std::size_t>(alignment));
+}
+
+void *operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t &) noexcept {
+    return counted_allocate(size, static_cast<std::size_t>(alignment));
+}
+
+// Both malloc and aligned_alloc memory is released with free, so every operator delete is the same
+void operator delete(void *ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void *ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void *ptr, std::size_t) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void *ptr, std::size_t) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void *ptr, std::align_val_t) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void *ptr, std::align_val_t) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void *ptr, std::size_t, std::align_val_t) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void *ptr, std::size_t, std::align_val_t) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void *ptr, const std::nothrow_t &) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void *ptr, const std::nothrow_t &) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void *ptr, std::align_val_t, const std::nothrow_t &) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void *ptr, std::align_val_t, const std::nothrow_t &) noexcept {
+    std::free(ptr);
+}
+#endif
+
+#endif // ALLOCATION_COUNTER_H
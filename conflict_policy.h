@@ -0,0 +1,76 @@
+#ifndef CONFLICT_POLICY_H
+#define CONFLICT_POLICY_H
+
+#include <concepts>
+
+#include "activity.h"
+#include "facilitator.h"
+#include "pair.h"
+
+// Partially built schedule, see search_arena.h
+class SearchNode;
+
+// A conflict policy is the cost model used to score a schedule. It is passed as a template
+// parameter so that the scoring in the search loop is resolved at compile time and inlined,
+// instead of going through a virtual call for every pairing.
+//
+// A policy provides:
+//  - repeated_pairing(pair): conflicts added each time a pairing is selected again
+//  - repeated_activity(facilitator, activity): conflicts added each time a facilitator leads
+//    an activity they have already led
+//  - assigned_activity(facilitator, activity): conflicts added every time a facilitator leads an
+//    activity, repeated or not. Soft preferences, such as keeping someone off an activity they
+//    dislike, go here.
+//  - lower_bound(node): fewest conflicts that the sessions still missing from a partial schedule
+//    can add, used to prune partial schedules that can't beat the best ones found so far
+//  - position_symmetric: false if the scores depend on who a facilitator is or which activity
+//    it is, and not only on the facilitator's position. The schedule counter then counts every
+//    session on its own. When it is true, the counter still checks that relabelling leaves
+//    every penalty as it is before relying on it.
+template<typename P>
+concept ConflictPolicy = requires(
+    const Pair &pair,
+    const Facilitator &facilitator,
+    const Activity &activity,
+    const SearchNode &node
+) {
+    { P::repeated_pairing(pair) } -> std::convertible_to<unsigned int>;
+    { P::repeated_activity(facilitator, activity) } -> std::convertible_to<unsigned int>;
+    { P::assigned_activity(facilitator, activity) } -> std::convertible_to<unsigned int>;
+    { P::lower_bound(node) } -> std::convertible_to<unsigned int>;
+    { P::position_symmetric } -> std::convertible_to<bool>;
+};
+
+// The original cost model: one conflict for each repeated pairing, and one conflict for each
+// facilitator that leads the same activity again. Leading an activity the first time is free.
+struct DefaultConflictPolicy {
+    static constexpr bool position_symmetric = true;
+
+    static unsigned int repeated_pairing(const Pair &) {
+        return 1;
+    }
+
+    static unsigned int repeated_activity(const Facilitator &, const Activity &) {
+        return 1;
+    }
+
+    static unsigned int assigned_activity(const Facilitator &, const Activity &) {
+        return 0;
+    }
+
+    // Nothing is assumed about the remaining sessions, which is always safe
+    static constexpr unsigned int lower_bound(const SearchNode &) {
+        return 0;
+    }
+};
+
+// Same as the default cost model, except that pairing the same two juniors again costs more,
+// since junior-junior pairings have no senior to lean on
+template<unsigned int JuniorPairingWeight = 3>
+struct JuniorPairingConflictPolicy : DefaultConflictPolicy {
+    static unsigned int repeated_pairing(const Pair &pair) {
+        return pair.is_junior_pairing() ? JuniorPairingWeight : 1;
+    }
+};
+
+#endif // CONFLICT_POLICY_H
@@ -0,0 +1,208 @@
+#ifndef JOB_H
+#define JOB_H
+
+#include <algorithm>
+#include <atomic>
+#include <istream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "facilitator.h"
+#include "schedule.h"
+#include "scored_session.h"
+#include "search_arena.h"
+
+// Default maximum conflicts of a job - only schedules with fewer conflicts are looked for
+constexpr unsigned int DEFAULT_MAX_CONFLICTS = 7;
+// Default number of best distinct schedules kept for a job
+constexpr unsigned int DEFAULT_NUM_RESULTS = 5;
+
+// Describes one camp to schedule: its roster, the maximum conflicts a schedule may have, and
+// how many of the best schedules to keep
+class Job {
+public:
+    std::string name;
+    std::vector<Facilitator> facilitators;
+    // Only schedules with fewer conflicts than this are looked for
+    unsigned int max_conflicts;
+    // Number of best distinct schedules to keep
+    unsigned int num_results;
+
+public:
+    Job(std::string n, unsigned int max_conflicts, unsigned int num_results = DEFAULT_NUM_RESULTS) :
+        name(n), max_conflicts(max_conflicts), num_results(num_results) {
+        if (name.empty()) {
+            throw std::invalid_argument("Job name cannot be an empty string");
+        }
+        if (num_results == 0) {
+            throw std::invalid_argument("Job must keep at least one schedule");
+        }
+    }
+
+    // Number of seniors and juniors on the roster. Jobs with the same shape have the same
+    // session permutations, up to the names of the facilitators.
+    std::pair<size_t, size_t> roster_shape() const {
+        size_t num_seniors = 0;
+        for (const Facilitator &facilitator : facilitators) {
+            if (!facilitator.is_junior()) num_seniors++;
+        }
+        return {num_seniors, facilitators.size() - num_seniors};
+    }
+
+    // File that the best schedules found for this job are written to
+    std::string output_file() const {
+        return name + ".txt";
+    }
+
+    // File that the best schedules found for this job are written to in binary form
+    std::string binary_output_file() const {
+        return name + ".bin";
+    }
+};
+
+// Read a list of jobs. Each job starts with a "job <name> [max conflicts] [number of schedules]"
+// line, followed by one "senior <name>" or "junior <name>" line per facilitator. Blank lines and
+// lines starting with '#' are ignored. Job names are used to name the output files, so they must
+// be unique and can't contain path separators. Each facilitator can only be listed once per job.
+// For example:
+//
+//   job camp_a 7 3
+//   senior Gabriella Gabon
+//   junior Adam Apples
+//   junior Betty Blues
+std::vector<Job> read_jobs(std::istream &in) {
+    std::vector<Job> jobs;
+    std::string line;
+    unsigned int line_number = 0;
+    while (std::getline(in, line)) {
+        line_number++;
+        std::istringstream words(line);
+        std::string keyword;
+        if (!(words >> keyword) || keyword[0] == '#') {
+            continue;
+        }
+        if (keyword == "job") {
+            std::string name;
+            unsigned int max_conflicts = DEFAULT_MAX_CONFLICTS;
+            unsigned int num_results = DEFAULT_NUM_RESULTS;
+            words >> name;
+            if (name.find_first_of("/\\") != std::string::npos) {
+                throw std::invalid_argument(
+                    "Invalid job name '" + name + "' on line " + std::to_string(line_number));
+            }
+            if (std::any_of(jobs.begin(), jobs.end(), [&name](const Job &job) { return job.name == name; })) {
+                throw std::invalid_argument(
+                    "Duplicate job name '" + name + "' on line " + std::to_string(line_number));
+            }
+            if (!(words >> std::ws).eof() && !(words >> max_conflicts)) {
+                throw std::invalid_argument(
+                    "Invalid max conflicts on line " + std::to_string(line_number));
+            }
+            if (!(words >> std::ws).eof() && !(words >> num_results)) {
+                throw std::invalid_argument(
+                    "Invalid number of schedules on line " + std::to_string(line_number));
+            }
+            jobs.emplace_back(name, max_conflicts, num_results);
+            continue;
+        }
+
+        Position position;
+        if (keyword == "senior") {
+            position = Position::senior;
+        } else if (keyword == "junior") {
+            position = Position::junior;
+        } else {
+            throw std::invalid_argument(
+                "Unexpected '" + keyword + "' on line " + std::to_string(line_number));
+        }
+        if (jobs.empty()) {
+            throw std::invalid_argument(
+                "Facilitator listed before any job on line " + std::to_string(line_number));
+        }
+        // The rest of the line is the facilitator's name
+        std::string name;
+        std::getline(words >> std::ws, name);
+        const std::vector<Facilitator> &facilitators = jobs.back().facilitators;
+        if (std::any_of(facilitators.begin(), facilitators.end(),
+                        [&name](const Facilitator &facilitator) { return facilitator.name == name; })) {
+            throw std::invalid_argument(
+                "Duplicate facilitator '" + name + "' on line " + std::to_string(line_number));
+        }
+        jobs.back().facilitators.emplace_back(name, position);
+    }
+    for (const Job &job : jobs) {
+        if (job.facilitators.empty()) {
+            throw std::invalid_argument("Job " + job.name + " has no facilitators");
+        }
+    }
+    return jobs;
+}
+
+// Search state for one job. Each job has its own conflict bound, while jobs with the same
+// roster shape share one table of session permutations.
+template<ConflictPolicy Policy>
+class SearchJob {
+public:
+    Job job;
+    // Thread pool lane that this job's tasks are queued on
+    size_t lane;
+    // Session permutations, built from placeholder facilitators of the same roster shape
+    std::shared_ptr<const std::vector<Session>> sessions;
+    // The same session permutations, scored for the search
+    std::shared_ptr<const ScoredSessionTable<Policy>> scored_sessions;
+    // Maps the placeholder facilitators in the sessions to this job's facilitators
+    std::unordered_map<Facilitator, Facilitator> roster;
+    // Schedules need fewer conflicts than this to be among the job's best schedules. Lowered by
+    // the result collector as it finds better schedules.
+    std::atomic<unsigned int> bound;
+
+public:
+    SearchJob(
+        const Job &job,
+        size_t lane,
+        std::shared_ptr<const std::vector<Session>> sessions,
+        std::shared_ptr<const ScoredSessionTable<Policy>> scored_sessions,
+        const std::vector<Facilitator> &placeholders
+    ) : job(job), lane(lane), sessions(sessions), scored_sessions(scored_sessions), bound(job.max_conflicts) {
+        // Without any sessions the job would get no search tasks and no output files at all
+        if (sessions->empty()) {
+            throw std::invalid_argument("Job " + job.name + " does not have enough facilitators to fill every activity");
+        }
+        if (scored_sessions->num_pairings > MAX_PAIRINGS ||
+            scored_sessions->num_facilitator_slots > MAX_FACILITATOR_SLOTS) {
+            throw std::invalid_argument("Job " + job.name + " has too many facilitators to search");
+        }
+        // Placeholders and the job's roster list seniors and juniors in the same order
+        std::vector<Facilitator> seniors, juniors;
+        for (const Facilitator &facilitator : job.facilitators) {
+            if (facilitator.is_junior()) juniors.push_back(facilitator);
+            else seniors.push_back(facilitator);
+        }
+        size_t senior_idx = 0, junior_idx = 0;
+        for (const Facilitator &placeholder : placeholders) {
+            roster[placeholder] =
+                placeholder.is_junior() ? juniors.at(junior_idx++) : seniors.at(senior_idx++);
+        }
+    }
+
+    // Name of the job's facilitator standing in for a placeholder facilitator
+    const std::string& name_of(const Facilitator &placeholder) const {
+        static const std::string empty_name;
+        if (placeholder.is_empty()) {
+            return empty_name;
+        }
+        return roster.at(placeholder).name;
+    }
+
+    // Index in the job's list of facilitators of the facilitator standing in for a placeholder
+    size_t index_of(const Facilitator &placeholder) const {
+        const Facilitator &facilitator = roster.at(placeholder);
+        return std::find(job.facilitators.begin(), job.facilitators.end(), facilitator) - job.facilitators.begin();
+    }
+};
+
+#endif // JOB_H
@@ -1,15 +1,29 @@
 #include <iostream>
 #include <algorithm>
-#include <chrono>
+#include <cctype>
+#include <charconv>
+#include <deque>
 #include <fstream>
 #include <future>
+#include <limits>
+#include <map>
+#include <memory>
+#include <optional>
+#include <unordered_set>
 #include <boost/multiprecision/cpp_int.hpp>
 
+#include "allocation_counter.h"
 #include "thread_pool.h"
 #include "activity.h"
 #include "facilitator.h"
+#include "job.h"
+#include "progress_monitor.h"
+#include "result_collector.h"
 #include "session.h"
 #include "schedule.h"
+#include "schedule_counter.h"
+#include "scored_session.h"
+#include "search_arena.h"
 
 // Helper to create arrays without needing provide an explicit size
 template<typename T, typename... N>
@@ -20,7 +34,7 @@ auto make_array(N&&... args) -> std::array<T,sizeof...(args)>
 
 // ------------------------ Global variables -------------------------
 
-// List of facilitators
+// List of facilitators scheduled when no batch of jobs is given
 const auto facilitators = make_array<Facilitator>(
     Facilitator("Adam Apples", Position::junior),
     Facilitator("Betty Blues", Position::junior),
@@ -35,56 +49,42 @@ const auto facilitators = make_array<Facilitator>(
 );
 
 const int num_activities = activities.size();
-// Will measure the start time of the algorithm
-std::chrono::high_resolution_clock::time_point start_time;
-// Will be used to measure the time that an interval began
-std::chrono::high_resolution_clock::time_point t1;
-// Contains every possible permutation of a session given the possible pairings
-std::unordered_set<Session> session_permutations;
-// Minimum schedule found out of all the schedule permutations. Initialize it with the
-// maximum conflicts you wish a schedule to have. The algorithm below will start looking for
-// schedules that are less than this maximum.
-//
-// Uncomment the following if you want to initially set maximum conflicts to a really high number
-//Schedule min_schedule{UINT_MAX};
-Schedule min_schedule{7};
-// Initialize the thread pool
-ThreadPool threadPool(std::thread::hardware_concurrency());
+// Every possible permutation of a session for each roster shape (number of seniors, number of
+// juniors). Jobs with the same roster shape share the same table.
+std::map<std::pair<size_t, size_t>, std::shared_ptr<const std::vector<Session>>> session_tables;
+// Cost model used to score schedules. Swap this for another ConflictPolicy (see
+// conflict_policy.h) to search with a different cost model - the search loop below is compiled
+// separately for each policy.
+using SchedulePolicy = DefaultConflictPolicy;
+// The session tables above, scored with the schedule policy
+std::map<std::pair<size_t, size_t>, std::shared_ptr<const ScoredSessionTable<SchedulePolicy>>> scored_session_tables;
+// Jobs being scheduled. Each job starts out looking for schedules with fewer conflicts than its
+// maximum - set the maximum to UINT_MAX to look for any schedule.
+std::deque<SearchJob<SchedulePolicy>> search_jobs;
+// Keeps the best schedules found for each job and writes them out on its own thread
+ResultCollector<SchedulePolicy> result_collector(search_jobs);
+// Adds up the iterations performed by the search and reports on them on its own thread
+ProgressMonitor progress_monitor;
+// Searches every schedule of a job that starts with the given session. Kept small and fixed-size
+// so that queueing it never allocates.
+struct SearchTask {
+    // Lane of the job to search
+    uint32_t lane = 0;
+    // Index of the first session in the job's session table
+    uint32_t first_session = 0;
+
+    void operator()(size_t worker) const;
+};
+// Initialize the thread pool, shared by all the jobs
+ThreadPool<SearchTask> threadPool(std::thread::hardware_concurrency());
+// Scratch space for each of the thread pool's workers, allocated up front so that the search
+// itself never allocates
+std::vector<SearchArena> search_arenas(threadPool.size());
 // ------------------------ End of Global variables section -------------------------
 
 
 // ------------------------ Main algorithm -------------------------
 
-// Print the Schedule into a file
-void print_schedule(const Schedule &schedule) {
-    // Create an ofstream object and open the file for writing (default mode is std::ios::out)
-    std::ofstream outFile("min_schedule.txt");
-    // Check if the file opened successfully
-    if (!outFile) {
-        std::cerr << "Error: Could not open the file." << std::endl;
-        return; // Return a non-zero value to indicate an error
-    }
-
-    int session_idx = 0;
-    for (const Session &session : schedule ) {
-        outFile << "=======================\n";
-        outFile << " Session " << session_idx << "\n";
-        outFile << "=======================\n";
-        for (const auto& [activity, pair] : session) {
-            outFile << activity << " - " << pair.p.first.name << " + " << pair.p.second.name << "\n";
-        }
-        outFile << "\n";
-        session_idx++;
-    }
-    outFile << "Schedule Conflicts: " << schedule.conflicts << "\n\n";
-
-    // Close the file
-    outFile.close();
-
-    // Inform the user that the operation was successful
-    std::cout << "Schedule with " << schedule.conflicts << " conflicts has been found!" << std::endl;
-}
-
 // Given a set of possible pairings and one selected pairing, generate a new set of possible pairings
 // by only including pairings from the list of possible pairings that are still valid to select
 std::unordered_set<Pair> generate_possible_pairings(
@@ -109,10 +109,47 @@ std::unordered_set<Pair> generate_possible_pairings(
     return remaining_pairings;
 }
 
+// Generate every possible pairing of the given facilitators: senior <--> junior pairings, junior
+// <--> junior pairings, and the empty pair
+std::unordered_set<Pair> generate_pairings(const std::vector<Facilitator> &roster) {
+    // Generate a set of all seniors and all juniors
+    std::unordered_set<Facilitator> seniors, juniors;
+    for (const Facilitator &facilitator : roster) {
+        if (facilitator.position.value() == Position::senior) seniors.insert(facilitator);
+        else juniors.insert(facilitator);
+    }
+
+    // Generate senior <--> junior pairings and junior <--> junior pairings
+    std::unordered_set<Pair> senior_junior_pairings, junior_junior_pairings;
+    for (const Facilitator &senior : seniors) {
+        for (const auto &junior : juniors) {
+            senior_junior_pairings.insert(Pair(senior, junior));
+        }
+    }
+    for (const Facilitator &juniorA : juniors) {
+        for (const Facilitator &juniorB : juniors) {
+            // You can't pair a junior with himself/herself
+            if (juniorA == juniorB) {
+                continue;
+            }
+            junior_junior_pairings.insert(Pair(juniorA, juniorB));
+        }
+    }
+
+    // Insert the senior - junior pairings into the set of all possible pairings
+    std::unordered_set<Pair> pairings = senior_junior_pairings;
+    // Insert the junior - junior pairings into the set of all possible pairings
+    pairings.insert(junior_junior_pairings.begin(), junior_junior_pairings.end());
+    // Insert the empty pair into the set of all possible pairings
+    pairings.insert(Pair());
+    return pairings;
+}
+
 // Recursively generate all possible permutations of a Session.
 void generate_sessions(
     const std::unordered_set<Pair> &possible_pairings,
-    Session &session
+    Session &session,
+    std::unordered_set<Session> &session_permutations
 ) {
     // If the Session is complete (ie. we have a pairing for each activity) then add it to the
     // set of Session permutations
@@ -128,156 +165,328 @@ void generate_sessions(
         std::unordered_set<Pair> remaining_available_pairings = generate_possible_pairings(selected_pairing, possible_pairings);
         std::cout << remaining_available_pairings.size() << std::endl;
         const Activity &activity = session.assign_pair(selected_pairing);
-        generate_sessions(remaining_available_pairings, session);
+        generate_sessions(remaining_available_pairings, session, session_permutations);
         session.free_activity(activity);
     }
 }
 
-// Update stats on the iterations performed so far
-void update_iterations(
-    const boost::multiprecision::uint128_t &new_full_iterations,
-    const boost::multiprecision::uint128_t &new_skipped_iterations
-) {
-    // Define a mutex to protect access to iteration counters
-    static std::mutex iteration_mutex;
-
-    // Lock the mutex to ensure exclusive access to iteration counters
-    std::lock_guard<std::mutex> lock(iteration_mutex);
-
-    using std::chrono::high_resolution_clock;
-    using std::chrono::duration_cast;
-    using std::chrono::milliseconds;
-    using std::chrono::seconds;
-    // Total number of schedule permutations iterated over (includes skipped permutations)
-    static boost::multiprecision::uint128_t total_iterations = 0;
-    // Total number of schedule permutations that were fully iterated over
-    static boost::multiprecision::uint128_t total_full_iterations = 0;
-    // Total number of schedule permutations skipped over
-    static boost::multiprecision::uint128_t total_skipped_iterations = 0;
-    // Last iteration count that we printed for, rounded down to the nearest trillion
-    static boost::multiprecision::uint128_t last_iteration_count_printed = 0;
-    // Print the iteration count every trillion iterations
-    static const boost::multiprecision::uint128_t granularity = 1000000000000;
-
-    total_full_iterations += new_full_iterations;
-    total_skipped_iterations += new_skipped_iterations;
-    total_iterations += ( new_full_iterations + new_skipped_iterations );
-    assert(total_full_iterations + total_skipped_iterations == total_iterations);
-
-    if (total_iterations - last_iteration_count_printed >= granularity) {
-        auto t2 = high_resolution_clock::now();
-        auto interval_ms_int = duration_cast<milliseconds>(t2 - t1);
-        auto total_s_int = duration_cast<seconds>(t2 - start_time);
-        // Save the last iteration count rounded down to the nearest trillion. For example, if the total
-        // iteration count is 4,765,432,000,000 the last iteration count will be 4,000,000,000,000.
-        // We do this to be able to print every 1T iterations.
-        last_iteration_count_printed = (total_iterations / granularity) * granularity;
-        std::stringstream out;
-        out << "Iteration count (in trillions): " << (last_iteration_count_printed / granularity) << "T, "<<
-                     "total time (s): " << total_s_int.count() << ", " <<
-                     "interval time (ms): " << interval_ms_int.count() << "\n";
-        out << "Full iterations: " << total_full_iterations << ", " <<
-                     "Skipped iterations: " << total_skipped_iterations << ", " <<
-                     "Total iterations: " << total_iterations << "\n\n";
-        std::cout << out.str() << std::endl;
-        // Reset the clock for the interval
-        t1 = high_resolution_clock::now();
+// Placeholder facilitators for a roster shape, seniors first. Session tables are built from
+// these so that they can be shared by every job with the same shape.
+std::vector<Facilitator> placeholder_roster(const std::pair<size_t, size_t> &shape) {
+    std::vector<Facilitator> roster;
+    for (size_t i = 0; i < shape.first; ++i) {
+        roster.emplace_back("Senior " + std::to_string(i + 1), Position::senior);
     }
+    for (size_t i = 0; i < shape.second; ++i) {
+        roster.emplace_back("Junior " + std::to_string(i + 1), Position::junior);
+    }
+    return roster;
 }
 
+// Returns the session permutations for a roster shape, generating them the first time the shape
+// is seen
+std::shared_ptr<const std::vector<Session>> session_table(const std::pair<size_t, size_t> &shape) {
+    auto it = session_tables.find(shape);
+    if (it != session_tables.end()) {
+        return it->second;
+    }
+
+    // Generate a set of all possible session permutations using the available pairings
+    std::unordered_set<Session> session_permutations;
+    Session session{};
+    generate_sessions(generate_pairings(placeholder_roster(shape)), session, session_permutations);
+
+    std::cout << "Number of possible session permutations for " << shape.first << " seniors and "
+              << shape.second << " juniors: " << session_permutations.size() << std::endl;
+    std::cout << "Number of possible iterations: " << pow(session_permutations.size(), NUM_SESSIONS) << "\n\n";
+
+    auto table = std::make_shared<const std::vector<Session>>(
+        session_permutations.begin(), session_permutations.end());
+    session_tables[shape] = table;
+    return table;
+}
+
+// Returns the scored session permutations for a roster shape, scoring them the first time the
+// shape is seen
+std::shared_ptr<const ScoredSessionTable<SchedulePolicy>> scored_session_table(const std::pair<size_t, size_t> &shape) {
+    auto it = scored_session_tables.find(shape);
+    if (it != scored_session_tables.end()) {
+        return it->second;
+    }
+    auto table = std::make_shared<const ScoredSessionTable<SchedulePolicy>>(*session_table(shape));
+    scored_session_tables[shape] = table;
+    return table;
+}
+
+// Number of search nodes a task visits before adding its iteration counts to the totals, so that
+// workers rarely contend on the progress monitor
+const uint64_t iteration_flush_nodes = 1 << 20;
+
 // Main algorithm to iterate over possible schedule permutations, calculate their conflict score,
-// and compare that score to the conflict score of the schedule with the fewest number of conflicts
-// found so far
-void generate_schedules(Schedule &schedule) {
-    static const int session_permutations_size = session_permutations.size();
-    // Define a mutex to protect access to min_schedule
-    static std::mutex min_schedule_mutex;
+// and compare that score to the conflict score of the job's best schedules found so far. Works
+// depth-first through the worker's arena, where arena.nodes[depth] holds the schedule to extend.
+// Iterations are counted into iterations. Schedules that can't be handed over to the result
+// collector right away wait in the outbox.
+template<ConflictPolicy Policy>
+void generate_schedules(
+    SearchJob<Policy> &job,
+    SearchArena &arena,
+    ResultOutbox &outbox,
+    unsigned int depth,
+    IterationCounts &iterations
+) {
+    if (++iterations.nodes == iteration_flush_nodes) {
+        progress_monitor.add(iterations);
+    }
+    const SearchNode &schedule = arena.nodes[depth];
+    const ScoredSessionTable<Policy> &sessions = *job.scored_sessions;
+    const int session_permutations_size = sessions.size();
+    const int remaining_sessions = NUM_SESSIONS - schedule.size;
+
+    if (schedule.conflicts + Policy::lower_bound(schedule) >= job.bound.load(std::memory_order_relaxed)) {
+        // Figure out how many schedule iterations were skipped and add that to the
+        // iteration count. Even if we skipped iterations, we assume they were performed
+        // for the purposes of printing the number of iterations performed.
+        iterations.skipped += boost::multiprecision::uint128_t(
+            pow(session_permutations_size, remaining_sessions));
+        return;
+    }
+    else if (schedule.complete()) {
+        // We've completed building a schedule that may be among the job's best - hand it over
+        // to the result collector, which ranks and writes it out on its own thread
+        result_collector.submit(job, schedule.conflicts, schedule.session_ids, outbox);
+        iterations.full += 1;
+        return;
+    }
+
+    // Iterate over each possible session, and add it to a copy of the schedule in the next node
+    // of the arena and recurse down further to build the schedule
+    SearchNode &next = arena.nodes[depth + 1];
+    for (uint32_t session_id = 0; session_id < sessions.size(); ++session_id) {
+        next = schedule;
+        next.add_session(session_id, sessions[session_id]);
+        generate_schedules(job, arena, outbox, depth + 1, iterations);
+    }
+}
+
+void SearchTask::operator()(size_t worker) const {
+    SearchJob<SchedulePolicy> &job = search_jobs[lane];
+    SearchArena &arena = search_arenas[worker];
 
+    arena.nodes[0] = SearchNode();
+    arena.nodes[1] = arena.nodes[0];
+    arena.nodes[1].add_session(first_session, (*job.scored_sessions)[first_session]);
+    IterationCounts iterations;
+    ResultOutbox outbox;
+    generate_schedules(job, arena, outbox, 1, iterations);
+    progress_monitor.add(iterations);
+    result_collector.flush(outbox, true);
+}
+
+// Search every job set up in search_jobs on the thread pool, and return once the best schedules
+// found have been written out
+void run_search() {
+    // Room for the tasks is reserved first so that the lanes don't grow while the workers are
+    // running
+    for (const SearchJob<SchedulePolicy> &job : search_jobs) {
+        threadPool.reserve(job.lane, job.sessions->size());
+    }
+    result_collector.start();
+    // Start the clock now for when the algorithm starts
+    progress_monitor.start();
     {
-        // Lock the mutex to ensure exclusive access to min_schedule
-        std::lock_guard<std::mutex> lock(min_schedule_mutex);
-        if (schedule.conflicts >= min_schedule.conflicts) {
-            // Figure out how many schedule iterations were skipped and add that to the
-            // iteration count. Even if we skipped iterations, we assume they were performed
-            // for the purposes of printing the number of iterations performed.
-            const int remaining_sessions = NUM_SESSIONS - schedule.size();
-            const boost::multiprecision::uint128_t iterations_skipped(
-                pow(session_permutations_size, remaining_sessions));
-            update_iterations(0, iterations_skipped);
-            return;
-        }
-        else if (schedule.complete()) {
-            // We've completed building a schedule and it has the fewest conflicts we've
-            // encountered so far - save it as such
-            min_schedule = schedule;
-            print_schedule(min_schedule);
-            update_iterations(1, 0);
-            return;
+        // Queueing the tasks counts towards the search's allocations, like running them does
+        CountAllocations count_allocations;
+        // Queue one task per first session of each job, on the job's lane
+        for (const SearchJob<SchedulePolicy> &job : search_jobs) {
+            for (uint32_t session_id = 0; session_id < job.sessions->size(); ++session_id) {
+                threadPool.enqueue(job.lane, SearchTask{static_cast<uint32_t>(job.lane), session_id});
+            }
         }
     }
+    threadPool.wait_finished();
+    progress_monitor.stop();
+    // Write out whatever results are still in flight
+    result_collector.stop();
+}
 
-    // Iterate over each possible session, and add it to the schedule and recurse down further
-    // to build the schedule
-    for (const auto &session : session_permutations) {
-        // Schedule the recursive function to run as a task
-        threadPool.enqueue([schedule, session]() mutable {
-            schedule.add_session(session);
-            generate_schedules(schedule);
-        });
+// Count the distinct schedules for each conflict score up to max_conflicts, and report how many
+// optimal schedules there are. Counting gets much slower as the conflicts allowed go up, so with
+// stop_at_optimal the count starts at 0 conflicts and only allows more while no schedule fits.
+void count_schedules(const std::vector<Session> &sessions, unsigned int max_conflicts, bool stop_at_optimal) {
+    std::vector<ScheduleCounter<SchedulePolicy>::Count> counts;
+    for (unsigned int budget = stop_at_optimal ? 0 : max_conflicts; budget <= max_conflicts; ++budget) {
+        ScheduleCounter<SchedulePolicy> counter(sessions, budget);
+        counts = counter.count();
+        if (counts.back() != 0) break;
     }
-}
 
-int main() {
-    // Generate a set of all seniors and all juniors
-    std::unordered_set<Facilitator> seniors, juniors;
-    for (const Facilitator &facilitator : facilitators) {
-        if (facilitator.position.value() == Position::senior) seniors.insert(facilitator);
-        else juniors.insert(facilitator);
+    for (unsigned int conflicts = 0; conflicts < counts.size(); ++conflicts) {
+        std::cout << "Schedules with " << conflicts << " conflicts: " << counts[conflicts] << std::endl;
     }
+    // The optimal schedules are the ones with the lowest conflict score that has any schedules
+    auto optimal = std::find_if(counts.begin(), counts.end(), [](const auto &count) { return count != 0; });
+    if (optimal == counts.end()) {
+        std::cout << "No schedules found with at most " << max_conflicts << " conflicts" << std::endl;
+        return;
+    }
+    std::cout << "Number of optimal schedules (" << (optimal - counts.begin()) << " conflicts): "
+              << *optimal << std::endl;
+}
 
-    // Generate senior <--> junior pairings and junior <--> junior pairings
-    std::unordered_set<Pair> senior_junior_pairings, junior_junior_pairings;
-    for (const Facilitator &senior : seniors) {
-        for (const auto &junior : juniors) {
-            senior_junior_pairings.insert(Pair(senior, junior));
+#ifdef COUNT_ALLOCATIONS
+// Search two hand-built session tables on the thread pool and report whether the search
+// allocated. Unlike the full search, this only takes seconds. The small table is searched for any
+// schedule, so that plenty of results are handed to the result collector. The larger one is
+// searched for schedules with fewer conflicts than it can have, so that nothing is found but each
+// task visits enough nodes to add its iteration counts to the totals part way through. Leaves
+// allocation_check output files behind.
+bool check_allocations() {
+    const std::vector<Facilitator> roster = placeholder_roster({2, 2});
+    const Facilitator &senior1 = roster[0], &senior2 = roster[1], &junior1 = roster[2], &junior2 = roster[3];
+    const std::pair<Pair, Pair> pair_ups[] = {
+        {Pair(senior1, junior1), Pair(senior2, junior2)},
+        {Pair(senior1, junior2), Pair(senior2, junior1)},
+        {Pair(senior1, senior2), Pair(junior1, junior2)},
+    };
+    // Each pair-up on two different pairs of activities for the small table, and on every ordered
+    // pair of different activities for the larger one, with the other activities left empty
+    auto small_sessions = std::make_shared<std::vector<Session>>();
+    auto large_sessions = std::make_shared<std::vector<Session>>();
+    for (const auto &[first, second] : pair_ups) {
+        for (int first_idx = 0; first_idx < num_activities; ++first_idx) {
+            for (int second_idx = 0; second_idx < num_activities; ++second_idx) {
+                if (first_idx == second_idx) continue;
+                Session session;
+                for (const char *activity : activities) {
+                    session[activity] = Pair();
+                }
+                session[activities[first_idx]] = first;
+                session[activities[second_idx]] = second;
+                if (first_idx % 2 == 0 && second_idx == first_idx + 1 && second_idx < 4) {
+                    small_sessions->push_back(session);
+                }
+                large_sessions->push_back(session);
+            }
         }
     }
-    for (const Facilitator &juniorA : juniors) {
-        for (const Facilitator &juniorB : juniors) {
-            // You can't pair a junior with himself/herself
-            if (juniorA == juniorB) {
-                continue;
+
+    // Six sessions hold twelve pairings, but the roster only makes six different ones, so no
+    // schedule has fewer than 6 conflicts
+    const std::pair<Job, std::shared_ptr<std::vector<Session>>> check_jobs[] = {
+        {Job("allocation_check_small", std::numeric_limits<unsigned int>::max()), small_sessions},
+        {Job("allocation_check_large", 4), large_sessions},
+    };
+    for (auto [job, sessions] : check_jobs) {
+        job.facilitators = roster;
+        search_jobs.emplace_back(job, search_jobs.size(), sessions,
+            std::make_shared<const ScoredSessionTable<SchedulePolicy>>(*sessions), roster);
+    }
+    run_search();
+
+    std::cout << "Heap allocations during the search: " << search_allocations << std::endl;
+    return search_allocations == 0;
+}
+#endif
+
+int main(int argc, char *argv[]) {
+    // Pass --count to count the optimal schedules instead of searching for one, or
+    // --count <max_conflicts> to count the schedules with each conflict score up to that. Pass
+    // --batch <jobs file> to schedule every job listed in the file (see read_jobs()). Both can be
+    // given together to count the schedules of every job in the file. In a build with
+    // -DCOUNT_ALLOCATIONS, pass --check-allocations to check that the search doesn't allocate.
+    try {
+        bool count_mode = false;
+        std::optional<unsigned int> count_max_conflicts;
+        const char *jobs_path = nullptr;
+        for (int arg_idx = 1; arg_idx < argc; ++arg_idx) {
+            const std::string arg = argv[arg_idx];
+            if (arg == "--batch") {
+                if (arg_idx + 1 >= argc) {
+                    throw std::invalid_argument("--batch requires a jobs file");
+                }
+                jobs_path = argv[++arg_idx];
+            } else if (arg == "--check-allocations") {
+#ifdef COUNT_ALLOCATIONS
+                return check_allocations() ? EXIT_SUCCESS : EXIT_FAILURE;
+#else
+                throw std::invalid_argument("--check-allocations requires a build with -DCOUNT_ALLOCATIONS");
+#endif
+            } else if (arg == "--count") {
+                count_mode = true;
+                if (arg_idx + 1 < argc && std::isdigit(static_cast<unsigned char>(argv[arg_idx + 1][0]))) {
+                    // The whole argument has to be a number, and one conflict is added to it
+                    // when sizing the counts, so the largest value is left out
+                    const std::string value = argv[++arg_idx];
+                    unsigned int max_conflicts;
+                    const auto [end, error] = std::from_chars(value.data(), value.data() + value.size(), max_conflicts);
+                    if (error != std::errc() || end != value.data() + value.size() ||
+                        max_conflicts == std::numeric_limits<unsigned int>::max()) {
+                        throw std::invalid_argument("Invalid max conflicts " + value + " for --count");
+                    }
+                    count_max_conflicts = max_conflicts;
+                }
+            } else {
+                throw std::invalid_argument("Unexpected argument " + arg);
             }
-            junior_junior_pairings.insert(Pair(juniorA, juniorB));
         }
-    }
 
-    // Insert the senior - junior pairings into the set of all possible pairings
-    std::unordered_set<Pair> pairings = senior_junior_pairings;
-    // Insert the junior - junior pairings into the set of all possible pairings
-    pairings.insert(junior_junior_pairings.begin(), junior_junior_pairings.end());
-    // Insert the empty pair into the set of all possible pairings
-    pairings.insert(Pair());
+        std::vector<Job> jobs;
+        if (jobs_path) {
+            std::ifstream jobs_file(jobs_path);
+            if (!jobs_file) {
+                throw std::invalid_argument(std::string("Could not open jobs file ") + jobs_path);
+            }
+            jobs = read_jobs(jobs_file);
+        } else {
+            jobs.emplace_back("min_schedule", DEFAULT_MAX_CONFLICTS);
+            jobs.back().facilitators.assign(facilitators.begin(), facilitators.end());
+        }
 
-    // Generate a set of all possible session permutations using the available pairings
-    Session session{};
-    generate_sessions(pairings, session);
+        if (count_mode) {
+            for (const Job &job : jobs) {
+                std::cout << "Counting schedules for " << job.name << std::endl;
+                const std::vector<Session> &sessions = *session_table(job.roster_shape());
+                if (sessions.empty()) {
+                    throw std::invalid_argument("Job " + job.name + " does not have enough facilitators to fill every activity");
+                }
+                if (count_max_conflicts) {
+                    count_schedules(sessions, *count_max_conflicts, false);
+                } else if (job.max_conflicts == 0) {
+                    // The search only looks for schedules with fewer conflicts than the job's
+                    // maximum, so there is nothing to count
+                    std::cout << "No schedules found with fewer than 0 conflicts" << std::endl;
+                } else {
+                    // Without a maximum, count up to the optimal schedules that the search would find
+                    count_schedules(sessions, job.max_conflicts - 1, true);
+                }
+            }
+            std::cout << "Exiting" << std::endl;
+            return EXIT_SUCCESS;
+        }
 
-    std::cout << "Number of possible session permutations: " << session_permutations.size() << std::endl;
-    std::cout << "Number of possible iterations: " << pow(session_permutations.size(), NUM_SESSIONS) << "\n\n";
+        // Set up every job before starting any of them, so that session tables are generated
+        // up front and shared between jobs with the same roster shape
+        for (const Job &job : jobs) {
+            const auto shape = job.roster_shape();
+            search_jobs.emplace_back(
+                job, search_jobs.size(), session_table(shape), scored_session_table(shape), placeholder_roster(shape));
+        }
 
-    try {
-        Schedule schedule;
-        // Start the clock now for when the algorithm starts
-        start_time = std::chrono::high_resolution_clock::now();
-        threadPool.enqueue([schedule]() mutable {
-            generate_schedules(schedule);
-        });
-        threadPool.wait_finished();
+        run_search();
+
+#ifdef COUNT_ALLOCATIONS
+        std::cout << "Heap allocations during the search: " << search_allocations << std::endl;
+        if (search_allocations != 0) {
+            return EXIT_FAILURE;
+        }
+#endif
     } catch (const std::exception& e) {
         std::cout << "Exception: " << e.what() << std::endl;
+        return EXIT_FAILURE;
     } catch (...) {
         std::cout << "Unknown exception caught!" << std::endl;
+        return EXIT_FAILURE;
     }
 
     std::cout << "Exiting" << std::endl;
@@ -0,0 +1,131 @@
+#ifndef PROGRESS_MONITOR_H
+#define PROGRESS_MONITOR_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <boost/multiprecision/cpp_int.hpp>
+
+// Iterations counted by one search task since it last added them to the totals
+struct IterationCounts {
+    // Schedule permutations that were fully iterated over
+    boost::multiprecision::uint128_t full = 0;
+    // Schedule permutations that were skipped over
+    boost::multiprecision::uint128_t skipped = 0;
+    // Search nodes visited
+    uint64_t nodes = 0;
+};
+
+// Keeps the totals of the iterations performed across all jobs, and reports on them from its own
+// thread. Workers only add their counts to the totals, so that formatting and printing the
+// report never happens on the search path.
+class ProgressMonitor {
+public:
+    ProgressMonitor() : stopping(false) {}
+
+    ~ProgressMonitor() {
+        stop();
+    }
+
+    // Start the clock and the reporting thread
+    void start() {
+        start_time = clock::now();
+        interval_start = start_time;
+        reporter = std::thread([this] { run(); });
+    }
+
+    // Stop the reporting thread
+    void stop() {
+        if (!reporter.joinable()) {
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        stop_condition.notify_one();
+        reporter.join();
+    }
+
+    // Add a search task's counts to the totals and reset them. Called from the worker threads.
+    void add(IterationCounts &counts) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            total_full_iterations += counts.full;
+            total_skipped_iterations += counts.skipped;
+        }
+        counts = IterationCounts();
+    }
+
+private:
+    using clock = std::chrono::high_resolution_clock;
+
+    // How often the totals are looked at
+    static constexpr std::chrono::seconds REPORT_INTERVAL{1};
+
+    // Report on the totals every interval, and once more when stopped so that the last counts
+    // added are not missed
+    void run() {
+        std::unique_lock<std::mutex> lock(mutex);
+        bool stopped = false;
+        while (!stopped) {
+            stopped = stop_condition.wait_for(lock, REPORT_INTERVAL, [this] { return stopping; });
+            const boost::multiprecision::uint128_t full_iterations = total_full_iterations;
+            const boost::multiprecision::uint128_t skipped_iterations = total_skipped_iterations;
+            lock.unlock();
+            report(full_iterations, skipped_iterations);
+            lock.lock();
+        }
+    }
+
+    // Print the iteration count every trillion iterations
+    void report(
+        const boost::multiprecision::uint128_t &full_iterations,
+        const boost::multiprecision::uint128_t &skipped_iterations
+    ) {
+        using std::chrono::duration_cast;
+        using std::chrono::milliseconds;
+        using std::chrono::seconds;
+        static const boost::multiprecision::uint128_t granularity = 1000000000000;
+
+        const boost::multiprecision::uint128_t total_iterations = full_iterations + skipped_iterations;
+        if (total_iterations - last_iteration_count_printed < granularity) {
+            return;
+        }
+        auto now = clock::now();
+        auto interval_ms_int = duration_cast<milliseconds>(now - interval_start);
+        auto total_s_int = duration_cast<seconds>(now - start_time);
+        // Save the last iteration count rounded down to the nearest trillion. For example, if the total
+        // iteration count is 4,765,432,000,000 the last iteration count will be 4,000,000,000,000.
+        last_iteration_count_printed = (total_iterations / granularity) * granularity;
+        std::stringstream out;
+        out << "Iteration count (in trillions): " << (last_iteration_count_printed / granularity) << "T, "<<
+                     "total time (s): " << total_s_int.count() << ", " <<
+                     "interval time (ms): " << interval_ms_int.count() << "\n";
+        out << "Full iterations: " << full_iterations << ", " <<
+                     "Skipped iterations: " << skipped_iterations << ", " <<
+                     "Total iterations: " << total_iterations << "\n\n";
+        std::cout << out.str() << std::endl;
+        // Reset the clock for the interval
+        interval_start = clock::now();
+    }
+
+private:
+    // Guards the totals and the stop flag
+    std::mutex mutex;
+    std::condition_variable stop_condition;
+    bool stopping;
+    std::thread reporter;
+    boost::multiprecision::uint128_t total_full_iterations = 0;
+    boost::multiprecision::uint128_t total_skipped_iterations = 0;
+    // Only touched by the reporting thread
+    boost::multiprecision::uint128_t last_iteration_count_printed = 0;
+    clock::time_point start_time;
+    clock::time_point interval_start;
+};
+
+#endif // PROGRESS_MONITOR_H
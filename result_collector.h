@@ -0,0 +1,359 @@
+#ifndef RESULT_COLLECTOR_H
+#define RESULT_COLLECTOR_H
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "activity.h"
+#include "job.h"
+#include "schedule.h"
+#include "search_arena.h"
+
+// A complete schedule found by the search, small enough to pass between threads without
+// allocating
+struct Result {
+    // Lane of the job that the schedule belongs to
+    uint32_t job;
+    uint32_t conflicts;
+    // Index of each session in the job's session table. The indices are sorted, so that two
+    // results are the same schedule (see schedule.h) exactly when their indices are equal.
+    SessionIds session_ids;
+};
+
+// Results that a worker couldn't hand over yet because the channel was full. Each search task
+// keeps one on its stack, so that a full channel doesn't make the worker wait for the writer.
+struct ResultOutbox {
+    static constexpr size_t CAPACITY = 64;
+
+    std::array<Result, CAPACITY> results;
+    size_t size = 0;
+};
+
+// Bounded lock-free queue that any number of threads can push onto. Each cell carries a sequence
+// number that tells pushers and poppers whose turn it is to use it.
+template<typename T, size_t Capacity>
+class ResultChannel {
+    static_assert((Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+    ResultChannel() : push_pos(0), pop_pos(0) {
+        for (size_t i = 0; i < Capacity; ++i) {
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    // Returns false if the channel is full
+    bool try_push(const T &value) {
+        size_t pos = push_pos.load(std::memory_order_relaxed);
+        while (true) {
+            Cell &cell = cells[pos & (Capacity - 1)];
+            const size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            const intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+            if (diff == 0) {
+                // The cell is free - claim it, unless another thread got to it first
+                if (push_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    cell.value = value;
+                    cell.sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                // The cell still holds a value that hasn't been popped
+                return false;
+            } else {
+                pos = push_pos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Returns false if the channel is empty
+    bool try_pop(T &value) {
+        size_t pos = pop_pos.load(std::memory_order_relaxed);
+        while (true) {
+            Cell &cell = cells[pos & (Capacity - 1)];
+            const size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            const intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos + 1);
+            if (diff == 0) {
+                if (pop_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    value = cell.value;
+                    // Hand the cell back to the pushers for the next lap around the buffer
+                    cell.sequence.store(pos + Capacity, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = pop_pos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        T value;
+    };
+
+    std::array<Cell, Capacity> cells;
+    // Kept on separate cache lines so pushers and the popper don't contend
+    alignas(64) std::atomic<size_t> push_pos;
+    alignas(64) std::atomic<size_t> pop_pos;
+};
+
+// Collects the complete schedules found by the search and keeps the best distinct ones for
+// each job. Worker threads only push results onto a lock-free channel. A dedicated writer thread
+// ranks them and writes the files, so that the search never waits on file I/O.
+//
+// For every job, the writer keeps <name>.txt with the best schedules in text form, best first,
+// and <name>.bin with the same schedules in a compact binary form:
+//   - "CSCH" magic, then format version, NUM_SESSIONS, NUM_ACTIVITIES and the number of
+//     facilitators, each as a uint32
+//   - each facilitator's position (uint8, 0 = senior, 1 = junior), name length (uint32) and name,
+//     in the order they are listed in the job
+//   - the number of schedules (uint32), then for each schedule its conflicts (uint32) and, for
+//     every session and every activity in `activities` order, the indices of the two
+//     facilitators in the pair (uint8 each, 0xFF for an empty pair)
+// Integers are written in the host's byte order.
+template<ConflictPolicy Policy>
+class ResultCollector {
+public:
+    explicit ResultCollector(std::deque<SearchJob<Policy>> &jobs) :
+        jobs(jobs), wakeups(0), stopping(false) {}
+
+    ~ResultCollector() {
+        stop();
+    }
+
+    // Start the writer thread. All jobs must have been added by now.
+    void start() {
+        top_results.assign(jobs.size(), {});
+        writer = std::thread([this] { run(); });
+    }
+
+    // Write out the remaining results and stop the writer thread
+    void stop() {
+        if (!writer.joinable()) {
+            return;
+        }
+        stopping = true;
+        wakeups.fetch_add(1);
+        wakeups.notify_one();
+        writer.join();
+    }
+
+    // Hand a complete schedule over to the writer thread. Called from the worker threads. If
+    // the channel is full, the schedule waits in the task's outbox instead. The worker only has
+    // to wait for the writer once the outbox is full too.
+    void submit(const SearchJob<Policy> &job, unsigned int conflicts, const SessionIds &session_ids, ResultOutbox &outbox) {
+        // The search goes through every ordering of a schedule's sessions, all with the same
+        // conflicts. Only the ordering with sorted session indices is handed over, so each
+        // schedule only comes through once.
+        if (!std::is_sorted(session_ids.begin(), session_ids.end())) {
+            return;
+        }
+        flush(outbox, false);
+        const Result result{static_cast<uint32_t>(job.lane), conflicts, session_ids};
+        if (channel.try_push(result)) {
+            wake_writer();
+            return;
+        }
+        if (outbox.size == ResultOutbox::CAPACITY) {
+            flush(outbox, true);
+        }
+        outbox.results[outbox.size++] = result;
+    }
+
+    // Hand the results in an outbox over to the writer thread. If wait is set, this waits for
+    // room in the channel until all of them have been handed over - search tasks do this once
+    // they are done.
+    void flush(ResultOutbox &outbox, bool wait) {
+        size_t handed_over = 0;
+        while (handed_over < outbox.size) {
+            if (channel.try_push(outbox.results[handed_over])) {
+                handed_over++;
+            } else if (wait) {
+                std::this_thread::yield();
+            } else {
+                break;
+            }
+        }
+        if (handed_over > 0) {
+            std::copy(outbox.results.begin() + handed_over, outbox.results.begin() + outbox.size,
+                      outbox.results.begin());
+            outbox.size -= handed_over;
+            wake_writer();
+        }
+    }
+
+private:
+    static constexpr uint32_t FORMAT_VERSION = 1;
+    static constexpr uint8_t EMPTY_FACILITATOR = 0xFF;
+
+    void wake_writer() {
+        wakeups.fetch_add(1, std::memory_order_release);
+        wakeups.notify_one();
+    }
+
+    void run() {
+        std::vector<bool> changed(jobs.size(), false);
+        while (true) {
+            // Read these before draining, so that a result or stop request that comes in while
+            // draining makes the wait below return right away
+            const unsigned int wakeup = wakeups.load(std::memory_order_acquire);
+            const bool stop_requested = stopping.load();
+
+            bool drained = drain(changed);
+            for (size_t lane = 0; lane < jobs.size(); ++lane) {
+                if (changed[lane]) {
+                    // Cleared first, so that a result drained in between the writes gets the
+                    // files written again on the next pass
+                    changed[lane] = false;
+                    write_text(jobs[lane], top_results[lane]);
+                    drained |= drain(changed);
+                    write_binary(jobs[lane], top_results[lane]);
+                    drained |= drain(changed);
+                }
+            }
+
+            if (!drained) {
+                if (stop_requested) {
+                    return;
+                }
+                wakeups.wait(wakeup, std::memory_order_acquire);
+            }
+        }
+    }
+
+    // Move every result waiting in the channel into the best results, marking the jobs whose
+    // best results changed. Returns true if there were any results.
+    bool drain(std::vector<bool> &changed) {
+        bool drained = false;
+        Result result;
+        while (channel.try_pop(result)) {
+            drained = true;
+            if (add_result(result)) {
+                changed[result.job] = true;
+            }
+        }
+        return drained;
+    }
+
+    // Add a result to its job's best results, keeping them sorted by conflicts. Returns true if
+    // the best results changed.
+    bool add_result(const Result &result) {
+        SearchJob<Policy> &job = jobs[result.job];
+        std::vector<Result> &results = top_results[result.job];
+        if (result.conflicts >= job.bound.load()) {
+            return false;
+        }
+        // Skip schedules that are already among the best results
+        for (const Result &other : results) {
+            if (other.session_ids == result.session_ids) {
+                return false;
+            }
+        }
+        auto it = std::upper_bound(results.begin(), results.end(), result,
+            [](const Result &a, const Result &b) { return a.conflicts < b.conflicts; });
+        results.insert(it, result);
+        if (results.size() > job.job.num_results) {
+            results.pop_back();
+        }
+        // Once the job has all of its results, only schedules better than the worst of them
+        // are worth looking for
+        if (results.size() == job.job.num_results) {
+            job.bound.store(results.back().conflicts);
+        }
+        std::cout << "Schedule with " << result.conflicts << " conflicts has been found for " << job.job.name << "!" << std::endl;
+        return true;
+    }
+
+    // Print the job's best Schedules into the job's text output file
+    static void write_text(const SearchJob<Policy> &job, const std::vector<Result> &results) {
+        std::ofstream outFile(job.job.output_file());
+        if (!outFile) {
+            std::cerr << "Error: Could not open the file." << std::endl;
+            return;
+        }
+
+        for (size_t result_idx = 0; result_idx < results.size(); ++result_idx) {
+            outFile << "#######################\n";
+            outFile << " Schedule " << result_idx + 1 << " of " << results.size() << "\n";
+            outFile << "#######################\n\n";
+            int session_idx = 0;
+            for (uint32_t session_id : results[result_idx].session_ids) {
+                const Session &session = (*job.sessions)[session_id];
+                outFile << "=======================\n";
+                outFile << " Session " << session_idx << "\n";
+                outFile << "=======================\n";
+                for (const auto& [activity, pair] : session) {
+                    outFile << activity << " - " << job.name_of(pair.p.first) << " + " << job.name_of(pair.p.second) << "\n";
+                }
+                outFile << "\n";
+                session_idx++;
+            }
+            outFile << "Schedule Conflicts: " << results[result_idx].conflicts << "\n\n";
+        }
+    }
+
+    // Write the job's best Schedules into the job's binary output file
+    static void write_binary(const SearchJob<Policy> &job, const std::vector<Result> &results) {
+        std::ofstream outFile(job.job.binary_output_file(), std::ios::binary);
+        if (!outFile) {
+            std::cerr << "Error: Could not open the file." << std::endl;
+            return;
+        }
+        auto write_u32 = [&outFile](uint32_t value) {
+            outFile.write(reinterpret_cast<const char *>(&value), sizeof(value));
+        };
+        auto write_u8 = [&outFile](uint8_t value) {
+            outFile.put(static_cast<char>(value));
+        };
+
+        outFile.write("CSCH", 4);
+        write_u32(FORMAT_VERSION);
+        write_u32(NUM_SESSIONS);
+        write_u32(NUM_ACTIVITIES);
+        write_u32(job.job.facilitators.size());
+        for (const Facilitator &facilitator : job.job.facilitators) {
+            write_u8(facilitator.is_junior() ? 1 : 0);
+            write_u32(facilitator.name.size());
+            outFile.write(facilitator.name.data(), facilitator.name.size());
+        }
+
+        write_u32(results.size());
+        for (const Result &result : results) {
+            write_u32(result.conflicts);
+            for (uint32_t session_id : result.session_ids) {
+                const Session &session = (*job.sessions)[session_id];
+                for (const char *activity : activities) {
+                    auto it = session.find(activity);
+                    if (it == session.end() || it->second.is_empty_pair()) {
+                        write_u8(EMPTY_FACILITATOR);
+                        write_u8(EMPTY_FACILITATOR);
+                        continue;
+                    }
+                    write_u8(job.index_of(it->second.p.first));
+                    write_u8(job.index_of(it->second.p.second));
+                }
+            }
+        }
+    }
+
+private:
+    std::deque<SearchJob<Policy>> &jobs;
+    // Best results of each job, indexed by lane. Only touched by the writer thread.
+    std::vector<std::vector<Result>> top_results;
+    ResultChannel<Result, 4096> channel;
+    // Bumped whenever there is something for the writer thread to do
+    std::atomic<unsigned int> wakeups;
+    std::atomic<bool> stopping;
+    std::thread writer;
+};
+
+#endif // RESULT_COLLECTOR_H
@@ -0,0 +1,566 @@
+#ifndef SCHEDULE_COUNTER_H
+#define SCHEDULE_COUNTER_H
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <set>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+#include <boost/multiprecision/cpp_int.hpp>
+
+#include "activity.h"
+#include "conflict_policy.h"
+#include "scored_session.h"
+#include "session.h"
+#include "schedule.h"
+
+// Counts how many distinct schedules exist for each conflict score, without building the
+// schedules one by one. Two schedules are the same if they contain the same sessions the same
+// number of times, in any order. Conflicts are scored with the given conflict policy.
+//
+// Counting is done in three steps:
+//  - Burnside's lemma turns counting unordered schedules into counting ordered sequences of
+//    sessions that stay the same under a permutation of the schedule's positions. Such a
+//    sequence is constant on each cycle of the permutation, so only one session has to be
+//    picked per cycle.
+//  - Those sequences are counted with memoization keyed on the conflict state (which pairings
+//    and which facilitator/activity combinations have been used so far). The conflicts added by
+//    the remaining sessions only depend on that state, not on the order sessions were added in.
+//    Each state also carries the sessions that still fit in its budget, so deeper levels only
+//    try the few sessions that are left instead of the whole table.
+//  - Relabelling the activities, or facilitators that share a position, maps sessions onto
+//    sessions without changing any conflict score. The first cycle only needs one
+//    representative session per symmetry class. After that, the relabellings that keep every
+//    session picked so far in place still map the remaining choices onto each other, so at
+//    every level only one session per orbit is tried and its count is scaled by the orbit's
+//    size. This only holds if relabelling leaves every penalty as it is, which is checked up
+//    front. Otherwise every session is its own class and no relabelling is used.
+template<ConflictPolicy Policy = DefaultConflictPolicy>
+class ScheduleCounter {
+public:
+    // Checked so that an overflow throws instead of silently reporting a wrong count
+    using Count = boost::multiprecision::checked_uint128_t;
+
+public:
+    // The sessions should be closed under the relabellings described above, which is the case
+    // for the session permutations built by generate_sessions(). Symmetry is not used for
+    // sessions that aren't, which gives the same counts, only more slowly.
+    ScheduleCounter(
+        const std::vector<Session> &sessions,
+        unsigned int max_conflicts,
+        unsigned int num_sessions = NUM_SESSIONS
+    ) : max_conflicts(max_conflicts), num_sessions(num_sessions), compact_sessions(sessions) {
+        // Counts are kept for every score up to and including max_conflicts
+        if (max_conflicts == std::numeric_limits<unsigned int>::max()) {
+            throw std::invalid_argument("Too many conflicts to count");
+        }
+        // Number every facilitator, and describe each session by the activity that each
+        // facilitator runs in it
+        std::unordered_map<Facilitator, uint8_t> facilitator_ids;
+        std::vector<Facilitator> facilitators;
+        std::set<std::pair<uint8_t, uint8_t>> pairings;
+        for (const Session &session : sessions) {
+            for (const auto& [activity, pair] : session) {
+                if (pair.is_empty_pair()) continue;
+                for (const Facilitator &facilitator : {pair.p.first, pair.p.second}) {
+                    if (facilitator_ids.try_emplace(facilitator, is_junior.size()).second) {
+                        is_junior.push_back(facilitator.is_junior());
+                        facilitators.push_back(facilitator);
+                    }
+                }
+                pairings.emplace(facilitator_ids.at(pair.p.first), facilitator_ids.at(pair.p.second));
+            }
+        }
+        if (is_junior.size() >= UNSCHEDULED) {
+            throw std::invalid_argument("Roster is too large to count");
+        }
+        signatures.reserve(sessions.size());
+        for (uint32_t session_idx = 0; session_idx < sessions.size(); ++session_idx) {
+            std::string signature(is_junior.size(), static_cast<char>(UNSCHEDULED));
+            for (const auto& [activity, pair] : sessions[session_idx]) {
+                if (pair.is_empty_pair()) continue;
+                const uint8_t activity_idx =
+                    std::find(activities.begin(), activities.end(), activity) - activities.begin();
+                signature[facilitator_ids.at(pair.p.first)] = activity_idx;
+                signature[facilitator_ids.at(pair.p.second)] = activity_idx;
+            }
+            session_ids.emplace(signature, session_idx);
+            signatures.push_back(std::move(signature));
+            all_sessions.push_back(session_idx);
+        }
+        symmetric = Policy::position_symmetric && closed_under_relabelling(facilitators, pairings);
+
+        std::map<std::tuple<int, int, int, int>, size_t> class_ids;
+        for (size_t session_idx = 0; session_idx < sessions.size(); ++session_idx) {
+            // Number of empty, junior-junior, senior-senior and senior-junior pairs. Sessions
+            // with the same counts belong to the same symmetry class.
+            std::tuple<int, int, int, int> shape{0, 0, 0, 0};
+            if (!symmetric) {
+                // Give every session a class of its own
+                std::get<0>(shape) = session_idx;
+            }
+            for (const auto& [activity, pair] : sessions[session_idx]) {
+                if (pair.is_empty_pair()) {
+                    if (symmetric) std::get<0>(shape)++;
+                }
+                else if (pair.is_junior_pairing()) std::get<1>(shape)++;
+                else if (!pair.p.first.is_junior() && !pair.p.second.is_junior()) std::get<2>(shape)++;
+                else std::get<3>(shape)++;
+            }
+
+            // The first session seen for a class becomes its representative
+            auto [it, inserted] = class_ids.try_emplace(shape, symmetry_classes.size());
+            if (inserted) {
+                symmetry_classes.push_back({session_idx, 0});
+            }
+            symmetry_classes[it->second].size++;
+        }
+    }
+
+    // Returns the number of distinct schedules for each conflict score from 0 up to and
+    // including max_conflicts, indexed by conflict score
+    std::vector<Count> count() {
+        std::vector<Count> numerators(max_conflicts + 1, 0);
+        Count num_orderings = 1;
+        for (unsigned int i = 2; i <= num_sessions; ++i) {
+            num_orderings *= i;
+        }
+
+        for (const auto &cycles : partitions(num_sessions)) {
+            // Number of permutations of the schedule positions with this cycle type
+            Count num_permutations = num_orderings;
+            std::map<unsigned int, unsigned int> multiplicities;
+            for (unsigned int cycle : cycles) {
+                num_permutations /= cycle;
+                multiplicities[cycle]++;
+            }
+            for (const auto& [cycle, multiplicity] : multiplicities) {
+                for (unsigned int i = 2; i <= multiplicity; ++i) {
+                    num_permutations /= i;
+                }
+            }
+
+            // Pick the first cycle's session from the symmetry class representatives, and scale
+            // each result by the size of its class
+            State state{
+                std::vector<bool>(compact_sessions.num_pairings, false),
+                std::vector<bool>(compact_sessions.num_facilitator_slots, false),
+                std::vector<unsigned int>(cycles.begin() + 1, cycles.end()),
+                0
+            };
+            std::vector<Count> fixed(max_conflicts + 1, 0);
+            for (const SymmetryClass &symmetry_class : symmetry_classes) {
+                State next = state;
+                const unsigned int conflicts =
+                    add_session(next, compact_sessions[symmetry_class.representative], cycles.front());
+                if (conflicts > max_conflicts) continue;
+                next.budget = max_conflicts - conflicts;
+                const std::vector<Count> &sub_counts =
+                    count_from(next, all_sessions, stabilizer(symmetry_class.representative));
+                for (unsigned int i = 0; i < sub_counts.size(); ++i) {
+                    fixed[i + conflicts] += sub_counts[i] * symmetry_class.size;
+                }
+            }
+            for (unsigned int i = 0; i <= max_conflicts; ++i) {
+                numerators[i] += fixed[i] * num_permutations;
+            }
+        }
+
+        // Burnside's lemma: the number of distinct schedules is the average number of
+        // sequences left unchanged by each permutation of the schedule positions
+        std::vector<Count> counts(max_conflicts + 1, 0);
+        for (unsigned int i = 0; i <= max_conflicts; ++i) {
+            assert(numerators[i] % num_orderings == 0 && "Burnside sum must divide evenly");
+            counts[i] = numerators[i] / num_orderings;
+        }
+        return counts;
+    }
+
+private:
+    // Marks a facilitator that doesn't run any activity in a session signature
+    static constexpr uint8_t UNSCHEDULED = 0xFF;
+    // Largest stabilizer worth listing out. Rosters with many facilitators left out of a session
+    // can have huge stabilizers - symmetry is skipped for those rather than listing them all.
+    static constexpr size_t MAX_STABILIZER_SIZE = 4096;
+
+    struct SymmetryClass {
+        // Index of the session counted on behalf of the whole class
+        size_t representative;
+        // Number of sessions in the class
+        unsigned int size;
+    };
+
+    // Relabelling of the activities and of the facilitators, where facilitators only swap with
+    // facilitators of the same position
+    struct Relabelling {
+        // New facilitator id of each facilitator
+        std::vector<uint8_t> facilitators;
+        // New activity index of each activity
+        std::array<uint8_t, NUM_ACTIVITIES> activities;
+    };
+
+    // Conflict state of a partially built sequence, along with what is left to build
+    struct State {
+        std::vector<bool> selected_pairings;
+        std::vector<bool> facilitator_activities;
+        // Lengths of the cycles that still need a session, longest first
+        std::vector<unsigned int> cycles;
+        // Number of conflicts the remaining sessions may still add
+        unsigned int budget;
+
+        bool operator==(const State &other) const {
+            return budget == other.budget &&
+                   cycles == other.cycles &&
+                   selected_pairings == other.selected_pairings &&
+                   facilitator_activities == other.facilitator_activities;
+        }
+    };
+
+    struct StateHash {
+        std::size_t operator()(const State &s) const {
+            std::size_t hashValue = std::hash<std::vector<bool>>()(s.selected_pairings);
+            hashValue ^= std::hash<std::vector<bool>>()(s.facilitator_activities) << 1;
+            for (unsigned int cycle : s.cycles) {
+                hashValue = hashValue * 31 + cycle;
+            }
+            return hashValue * 31 + s.budget;
+        }
+    };
+
+    // All the ways to split n into cycle lengths, each listed longest first
+    static std::vector<std::vector<unsigned int>> partitions(unsigned int n) {
+        std::vector<std::vector<unsigned int>> result;
+        std::vector<unsigned int> current;
+        partitions(n, n, current, result);
+        return result;
+    }
+
+    static void partitions(
+        unsigned int n,
+        unsigned int largest,
+        std::vector<unsigned int> &current,
+        std::vector<std::vector<unsigned int>> &result
+    ) {
+        if (n == 0) {
+            result.push_back(current);
+            return;
+        }
+        for (unsigned int part = std::min(n, largest); part > 0; --part) {
+            current.push_back(part);
+            partitions(n - part, part, current, result);
+            current.pop_back();
+        }
+    }
+
+    // Relabelling that leaves everything where it is
+    Relabelling identity() const {
+        Relabelling relabelling;
+        for (uint8_t facilitator = 0; facilitator < is_junior.size(); ++facilitator) {
+            relabelling.facilitators.push_back(facilitator);
+        }
+        for (uint8_t activity = 0; activity < NUM_ACTIVITIES; ++activity) {
+            relabelling.activities[activity] = activity;
+        }
+        return relabelling;
+    }
+
+    // Index of the session that a relabelling maps the given session to, or all_sessions.size()
+    // if that session isn't in the table
+    uint32_t relabel(const Relabelling &relabelling, uint32_t session_idx) {
+        const std::string &signature = signatures[session_idx];
+        relabelled.assign(signature.size(), static_cast<char>(UNSCHEDULED));
+        for (size_t facilitator = 0; facilitator < signature.size(); ++facilitator) {
+            if (static_cast<uint8_t>(signature[facilitator]) == UNSCHEDULED) continue;
+            relabelled[relabelling.facilitators[facilitator]] =
+                static_cast<char>(relabelling.activities[static_cast<uint8_t>(signature[facilitator])]);
+        }
+        auto it = session_ids.find(relabelled);
+        return it == session_ids.end() ? all_sessions.size() : it->second;
+    }
+
+    // Check that relabelling never takes a session out of the table, and never changes the
+    // penalty of a pairing or of a facilitator on an activity, so that the counts can't change
+    // either. Swapping two activities, rotating the activities, and swapping or rotating the
+    // facilitators of one position generate every relabelling, so it is enough to check those.
+    bool closed_under_relabelling(
+        const std::vector<Facilitator> &facilitators,
+        const std::set<std::pair<uint8_t, uint8_t>> &pairings
+    ) {
+        std::vector<Relabelling> generators;
+        Relabelling swap_activities = identity();
+        std::swap(swap_activities.activities[0], swap_activities.activities[1]);
+        generators.push_back(swap_activities);
+        Relabelling rotate_activities = identity();
+        std::rotate(rotate_activities.activities.begin(), rotate_activities.activities.begin() + 1,
+                    rotate_activities.activities.end());
+        generators.push_back(rotate_activities);
+        for (bool junior : {false, true}) {
+            std::vector<uint8_t> same_position;
+            for (uint8_t facilitator = 0; facilitator < is_junior.size(); ++facilitator) {
+                if (is_junior[facilitator] == junior) same_position.push_back(facilitator);
+            }
+            if (same_position.size() < 2) continue;
+            Relabelling swap_facilitators = identity();
+            std::swap(swap_facilitators.facilitators[same_position[0]],
+                      swap_facilitators.facilitators[same_position[1]]);
+            generators.push_back(swap_facilitators);
+            Relabelling rotate_facilitators = identity();
+            for (size_t i = 0; i < same_position.size(); ++i) {
+                rotate_facilitators.facilitators[same_position[i]] =
+                    same_position[(i + 1) % same_position.size()];
+            }
+            generators.push_back(rotate_facilitators);
+        }
+
+        for (const Relabelling &generator : generators) {
+            for (uint32_t session_idx : all_sessions) {
+                if (relabel(generator, session_idx) == all_sessions.size()) {
+                    return false;
+                }
+            }
+            for (size_t facilitator = 0; facilitator < facilitators.size(); ++facilitator) {
+                const Facilitator &image = facilitators[generator.facilitators[facilitator]];
+                for (size_t activity = 0; activity < NUM_ACTIVITIES; ++activity) {
+                    const Activity from = activities[activity];
+                    const Activity to = activities[generator.activities[activity]];
+                    if (Policy::repeated_activity(facilitators[facilitator], from) != Policy::repeated_activity(image, to) ||
+                        Policy::assigned_activity(facilitators[facilitator], from) != Policy::assigned_activity(image, to)) {
+                        return false;
+                    }
+                }
+            }
+            for (const auto &[first, second] : pairings) {
+                const Pair pair(facilitators[first], facilitators[second]);
+                const Pair image(facilitators[generator.facilitators[first]], facilitators[generator.facilitators[second]]);
+                if (Policy::repeated_pairing(pair) != Policy::repeated_pairing(image)) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    // Every relabelling that leaves the given session as it is. Just the identity if symmetry
+    // isn't used, or if there are too many of them.
+    std::vector<Relabelling> stabilizer(uint32_t session_idx) {
+        const std::vector<Relabelling> trivial{identity()};
+        if (!symmetric) {
+            return trivial;
+        }
+
+        // Facilitators running each activity, and the ones left out of the session
+        const std::string &signature = signatures[session_idx];
+        std::array<std::vector<uint8_t>, NUM_ACTIVITIES> running;
+        std::array<std::vector<uint8_t>, 2> unscheduled;
+        for (uint8_t facilitator = 0; facilitator < signature.size(); ++facilitator) {
+            const uint8_t activity = static_cast<uint8_t>(signature[facilitator]);
+            if (activity == UNSCHEDULED) unscheduled[is_junior[facilitator]].push_back(facilitator);
+            else running[activity].push_back(facilitator);
+        }
+        // Number of seniors and juniors running an activity
+        auto shape_of = [&](uint8_t activity) {
+            unsigned int num_juniors = 0;
+            for (uint8_t facilitator : running[activity]) num_juniors += is_junior[facilitator];
+            return std::make_pair(running[activity].size() - num_juniors, num_juniors);
+        };
+
+        // The activities can be relabelled in any way that keeps the shape of each activity,
+        // and then every group of facilitators has to be mapped onto the group in the same
+        // place with the same position, in any order
+        std::vector<Relabelling> relabellings;
+        std::array<uint8_t, NUM_ACTIVITIES> activity_map;
+        for (uint8_t activity = 0; activity < NUM_ACTIVITIES; ++activity) {
+            activity_map[activity] = activity;
+        }
+        do {
+            bool keeps_shapes = true;
+            for (uint8_t activity = 0; activity < NUM_ACTIVITIES; ++activity) {
+                keeps_shapes = keeps_shapes && shape_of(activity) == shape_of(activity_map[activity]);
+            }
+            if (!keeps_shapes) continue;
+
+            // Pairs of facilitator groups to map onto each other
+            std::vector<std::pair<std::vector<uint8_t>, std::vector<uint8_t>>> groups;
+            size_t num_relabellings = 1;
+            auto add_group = [&](std::vector<uint8_t> from, std::vector<uint8_t> to) {
+                for (size_t i = 2; i <= from.size(); ++i) {
+                    num_relabellings = std::min(num_relabellings * i, MAX_STABILIZER_SIZE + 1);
+                }
+                groups.emplace_back(std::move(from), std::move(to));
+            };
+            for (uint8_t activity = 0; activity < NUM_ACTIVITIES; ++activity) {
+                for (bool junior : {false, true}) {
+                    std::vector<uint8_t> from, to;
+                    for (uint8_t facilitator : running[activity]) {
+                        if (is_junior[facilitator] == junior) from.push_back(facilitator);
+                    }
+                    for (uint8_t facilitator : running[activity_map[activity]]) {
+                        if (is_junior[facilitator] == junior) to.push_back(facilitator);
+                    }
+                    add_group(from, to);
+                }
+            }
+            add_group(unscheduled[0], unscheduled[0]);
+            add_group(unscheduled[1], unscheduled[1]);
+            if (relabellings.size() + num_relabellings > MAX_STABILIZER_SIZE) {
+                return trivial;
+            }
+
+            Relabelling relabelling = identity();
+            relabelling.activities = activity_map;
+            add_relabellings(groups, 0, relabelling, relabellings);
+        } while (std::next_permutation(activity_map.begin(), activity_map.end()));
+        return relabellings;
+    }
+
+    // Add every way of mapping the facilitator groups from group_idx on, on top of a partly
+    // filled in relabelling
+    static void add_relabellings(
+        std::vector<std::pair<std::vector<uint8_t>, std::vector<uint8_t>>> &groups,
+        size_t group_idx,
+        Relabelling &relabelling,
+        std::vector<Relabelling> &relabellings
+    ) {
+        if (group_idx == groups.size()) {
+            relabellings.push_back(relabelling);
+            return;
+        }
+        auto &[from, to] = groups[group_idx];
+        std::sort(to.begin(), to.end());
+        do {
+            for (size_t i = 0; i < from.size(); ++i) {
+                relabelling.facilitators[from[i]] = to[i];
+            }
+            add_relabellings(groups, group_idx + 1, relabelling, relabellings);
+        } while (std::next_permutation(to.begin(), to.end()));
+    }
+
+    // Add a session to the state `repeat` times in a row and return the number of conflicts
+    // that adds, using the same scoring as SearchNode::add_session()
+    static unsigned int add_session(State &state, const ScoredSession &session, unsigned int repeat) {
+        unsigned int conflicts = session.assigned_conflicts * repeat;
+        for (const auto &[pairing, penalty] : session.pairing_penalties()) {
+            conflicts += penalty * (state.selected_pairings[pairing] ? repeat : repeat - 1);
+            state.selected_pairings[pairing] = true;
+        }
+        for (const auto &[slot, penalty] : session.facilitator_slot_penalties()) {
+            conflicts += penalty * (state.facilitator_activities[slot] ? repeat : repeat - 1);
+            state.facilitator_activities[slot] = true;
+        }
+        return conflicts;
+    }
+
+    // Same as add_session() but only computes the conflicts, stopping early once they go past
+    // the budget
+    static unsigned int added_conflicts(const State &state, const ScoredSession &session, unsigned int repeat) {
+        unsigned int conflicts = session.assigned_conflicts * repeat;
+        if (conflicts > state.budget) return conflicts;
+        for (const auto &[pairing, penalty] : session.pairing_penalties()) {
+            conflicts += penalty * (state.selected_pairings[pairing] ? repeat : repeat - 1);
+            if (conflicts > state.budget) return conflicts;
+        }
+        for (const auto &[slot, penalty] : session.facilitator_slot_penalties()) {
+            conflicts += penalty * (state.facilitator_activities[slot] ? repeat : repeat - 1);
+            if (conflicts > state.budget) return conflicts;
+        }
+        return conflicts;
+    }
+
+    // Returns the number of ways to assign a session to each remaining cycle, indexed by the
+    // number of conflicts added on top of the state. The candidates must include every session
+    // that fits in the state's budget, and the symmetries must leave every session picked so
+    // far in place.
+    const std::vector<Count>& count_from(
+        const State &state,
+        const std::vector<uint32_t> &candidates,
+        const std::vector<Relabelling> &symmetries
+    ) {
+        auto it = memo.find(state);
+        if (it != memo.end()) {
+            return it->second;
+        }
+
+        std::vector<Count> counts(state.budget + 1, 0);
+        if (state.cycles.empty()) {
+            counts[0] = 1;
+            return memo.emplace(state, counts).first->second;
+        }
+
+        // Sessions only ever get more expensive as the state fills up, so the ones that don't
+        // fit in the budget now can be dropped for good
+        std::vector<uint32_t> remaining;
+        for (uint32_t session_idx : candidates) {
+            if (added_conflicts(state, compact_sessions[session_idx], 1) <= state.budget) {
+                remaining.push_back(session_idx);
+            }
+        }
+
+        const unsigned int repeat = state.cycles.front();
+        std::vector<Relabelling> fixers;
+        for (uint32_t session_idx : remaining) {
+            const ScoredSession &session = compact_sessions[session_idx];
+            const unsigned int conflicts = added_conflicts(state, session, repeat);
+            if (conflicts > state.budget) continue;
+            if (state.cycles.size() == 1) {
+                // Last cycle - nothing left to recurse into
+                counts[conflicts]++;
+                continue;
+            }
+
+            // Only the smallest session of each orbit is recursed into. The relabellings that
+            // also leave it in place are the symmetries left for the next level.
+            fixers.clear();
+            bool smallest = true;
+            for (const Relabelling &symmetry : symmetries) {
+                const uint32_t image = symmetries.size() > 1 ? relabel(symmetry, session_idx) : session_idx;
+                if (image < session_idx) {
+                    smallest = false;
+                    break;
+                }
+                if (image == session_idx) fixers.push_back(symmetry);
+            }
+            if (!smallest) continue;
+            const size_t orbit_size = symmetries.size() / fixers.size();
+
+            State next = state;
+            add_session(next, session, repeat);
+            next.cycles.erase(next.cycles.begin());
+            next.budget = state.budget - conflicts;
+            const std::vector<Count> &sub_counts = count_from(next, remaining, fixers);
+            for (unsigned int i = 0; i < sub_counts.size(); ++i) {
+                counts[i + conflicts] += sub_counts[i] * orbit_size;
+            }
+        }
+        return memo.emplace(state, counts).first->second;
+    }
+
+private:
+    // Highest conflict score to count schedules for
+    unsigned int max_conflicts;
+    // Number of sessions in a schedule
+    unsigned int num_sessions;
+    // Sessions stripped down to what the conflict score depends on
+    ScoredSessionTable<Policy> compact_sessions;
+    // Whether relabelling can be used to skip over sessions
+    bool symmetric;
+    std::vector<SymmetryClass> symmetry_classes;
+    // Whether each facilitator is a junior, indexed by facilitator id
+    std::vector<bool> is_junior;
+    // Activity index that each facilitator runs in a session, or UNSCHEDULED, for each session
+    std::vector<std::string> signatures;
+    // Index of each session, keyed on its signature
+    std::unordered_map<std::string, uint32_t> session_ids;
+    // Index of every session, in order
+    std::vector<uint32_t> all_sessions;
+    // Scratch signature for relabel(), so that it doesn't allocate each time
+    std::string relabelled;
+    // Memoized sub-results, keyed on conflict state
+    std::unordered_map<State, std::vector<Count>, StateHash> memo;
+};
+
+#endif // SCHEDULE_COUNTER_H
@@ -0,0 +1,112 @@
+#ifndef SCORED_SESSION_H
+#define SCORED_SESSION_H
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+#include "activity.h"
+#include "conflict_policy.h"
+#include "session.h"
+
+// Session reduced to what its conflict score depends on. It is stored inline so that scoring it
+// during the search never touches the heap.
+class ScoredSession {
+public:
+    // Id of something that adds conflicts when it is repeated, and how many it adds
+    struct Scored {
+        uint16_t id;
+        uint16_t conflicts;
+    };
+
+public:
+    // Number of non-empty pairs in the session
+    unsigned int num_pairings = 0;
+    // Conflicts added every time the session is added, repeated or not
+    uint32_t assigned_conflicts = 0;
+    // Ids of the non-empty pairs in the session
+    std::array<Scored, NUM_ACTIVITIES> pairings;
+    // activity index * number of facilitators + facilitator id, for each scheduled facilitator
+    std::array<Scored, 2 * NUM_ACTIVITIES> facilitator_slots;
+
+public:
+    std::span<const Scored> pairing_penalties() const {
+        return {pairings.data(), num_pairings};
+    }
+
+    std::span<const Scored> facilitator_slot_penalties() const {
+        return {facilitator_slots.data(), 2 * num_pairings};
+    }
+};
+
+// Scored version of a table of sessions, in the same order. Pairings and facilitators are
+// numbered in the order they are first seen, and penalties come from the conflict policy.
+template<ConflictPolicy Policy>
+class ScoredSessionTable : public std::vector<ScoredSession> {
+public:
+    // Number of distinct non-empty pairs across all sessions
+    size_t num_pairings;
+    // Number of facilitator/activity combinations across all sessions
+    size_t num_facilitator_slots;
+
+public:
+    explicit ScoredSessionTable(const std::vector<Session> &sessions) {
+        std::unordered_map<Facilitator, unsigned int> facilitator_ids;
+        std::unordered_map<Pair, unsigned int> pair_ids;
+        for (const Session &session : sessions) {
+            for (const auto& [activity, pair] : session) {
+                if (pair.is_empty_pair()) continue;
+                facilitator_ids.try_emplace(pair.p.first, facilitator_ids.size());
+                facilitator_ids.try_emplace(pair.p.second, facilitator_ids.size());
+                pair_ids.try_emplace(pair, pair_ids.size());
+            }
+        }
+        num_pairings = pair_ids.size();
+        num_facilitator_slots = facilitator_ids.size() * NUM_ACTIVITIES;
+        if (num_pairings > UINT16_MAX || num_facilitator_slots > UINT16_MAX) {
+            throw std::invalid_argument("Roster is too large to score");
+        }
+
+        reserve(sessions.size());
+        for (const Session &session : sessions) {
+            ScoredSession scored;
+            for (const auto& [activity, pair] : session) {
+                if (pair.is_empty_pair()) continue;
+                const size_t activity_idx =
+                    std::find(activities.begin(), activities.end(), activity) - activities.begin();
+                auto slot_of = [&](const Facilitator &facilitator) {
+                    return static_cast<uint16_t>(activity_idx * facilitator_ids.size() + facilitator_ids.at(facilitator));
+                };
+                scored.facilitator_slots[2 * scored.num_pairings] = {
+                    slot_of(pair.p.first),
+                    penalty(Policy::repeated_activity(pair.p.first, activity))
+                };
+                scored.facilitator_slots[2 * scored.num_pairings + 1] = {
+                    slot_of(pair.p.second),
+                    penalty(Policy::repeated_activity(pair.p.second, activity))
+                };
+                scored.assigned_conflicts += penalty(Policy::assigned_activity(pair.p.first, activity));
+                scored.assigned_conflicts += penalty(Policy::assigned_activity(pair.p.second, activity));
+                scored.pairings[scored.num_pairings++] = {
+                    static_cast<uint16_t>(pair_ids.at(pair)),
+                    penalty(Policy::repeated_pairing(pair))
+                };
+            }
+            push_back(scored);
+        }
+    }
+
+private:
+    // Penalties are stored in 16 bits, so a bigger one throws instead of silently wrapping
+    static uint16_t penalty(unsigned int conflicts) {
+        if (conflicts > UINT16_MAX) {
+            throw std::invalid_argument("Conflict policy penalty is too large to score");
+        }
+        return static_cast<uint16_t>(conflicts);
+    }
+};
+
+#endif // SCORED_SESSION_H
@@ -0,0 +1,68 @@
+#ifndef SEARCH_ARENA_H
+#define SEARCH_ARENA_H
+
+#include <array>
+#include <bitset>
+#include <cstdint>
+
+#include "schedule.h"
+#include "scored_session.h"
+
+// Largest number of distinct pairings and facilitator/activity combinations that the search
+// can track. Jobs with bigger rosters are rejected up front.
+constexpr size_t MAX_PAIRINGS = 256;
+constexpr size_t MAX_FACILITATOR_SLOTS = 64 * NUM_ACTIVITIES;
+
+// Index of each session of a schedule in its job's session table
+using SessionIds = std::array<uint32_t, NUM_SESSIONS>;
+
+// Partially built schedule, along with what its conflict score depends on. The state is stored
+// inline with fixed-size bitsets, so that copying and extending it never allocates.
+class SearchNode {
+public:
+    // Number of conflicts in the schedule
+    unsigned int conflicts = 0;
+    // Number of sessions in the schedule
+    unsigned int size = 0;
+    // Index in the job's session table of each session in the schedule
+    SessionIds session_ids{};
+    // Which pairings have already been selected
+    std::bitset<MAX_PAIRINGS> selected_pairings;
+    // Which facilitators have already run which activities
+    std::bitset<MAX_FACILITATOR_SLOTS> facilitator_activities;
+
+public:
+    bool complete() const {
+        return size == NUM_SESSIONS;
+    }
+
+    // Add a session to the schedule. Empty pairs aren't part of a scored session, so they never
+    // add conflicts.
+    void add_session(uint32_t session_id, const ScoredSession &session) {
+        // Soft preferences add the same conflicts whether the session is new or not
+        conflicts += session.assigned_conflicts;
+        // If a pairing from the new session has already been seen before in this schedule, add
+        // the policy's penalty to the conflict score
+        for (const auto &[pairing, penalty] : session.pairing_penalties()) {
+            if (selected_pairings[pairing]) conflicts += penalty;
+            selected_pairings[pairing] = true;
+        }
+        // For each facilitator in the session, if they've been scheduled before for the same
+        // activity in another session, then add the policy's penalty to the conflict score
+        for (const auto &[slot, penalty] : session.facilitator_slot_penalties()) {
+            if (facilitator_activities[slot]) conflicts += penalty;
+            facilitator_activities[slot] = true;
+        }
+        session_ids[size++] = session_id;
+    }
+};
+
+// Scratch space owned by one worker thread. The search works depth-first through the nodes,
+// with nodes[i] holding the schedule built from the first i sessions. Aligned to a cache line so
+// that workers writing to neighbouring arenas don't share one.
+class alignas(64) SearchArena {
+public:
+    std::array<SearchNode, NUM_SESSIONS + 1> nodes;
+};
+
+#endif // SEARCH_ARENA_H
@@ -68,8 +68,15 @@ namespace std {
         size_t operator()(const Session& s) const {
             size_t hashVal = 0;
             for (const auto& [activity, pair] : s) {
-                // Combine hashes of activity and pair using XOR
-                hashVal ^= std::hash<Activity>()(activity) ^ std::hash<Pair>()(pair);
+                // Mix the hashes of activity and pair before combining them. XOR-ing them
+                // straight in gives every session made of the same pairs the same hash, no
+                // matter which activity each pair is on. The entries are added up since the
+                // map's order isn't fixed.
+                size_t entry = std::hash<Activity>()(activity) ^ (std::hash<Pair>()(pair) * 0x9E3779B97F4A7C15);
+                entry ^= entry >> 31;
+                entry *= 0xBF58476D1CE4E5B9;
+                entry ^= entry >> 27;
+                hashVal += entry;
             }
             return hashVal;
         }
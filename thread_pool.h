@@ -1,35 +1,89 @@
 #ifndef THREAD_POOL_H
 #define THREAD_POOL_H
 
+#include <condition_variable>
 #include <iostream>
+#include <mutex>
 #include <thread>
+#include <vector>
+
+#include "allocation_counter.h"
+
+// Queue of tasks stored back to back in one block of memory. Once enough room
+// has been reserved, pushing and popping never allocate.
+template<typename Task>
+class TaskSlab {
+public:
+    void reserve(size_t capacity) {
+        tasks.reserve(capacity);
+    }
+
+    bool empty() const {
+        return head == tasks.size();
+    }
+
+    void push(const Task &task) {
+        tasks.push_back(task);
+    }
+
+    Task pop() {
+        Task task = tasks[head++];
+        if (empty()) {
+            // Start over at the beginning of the block, keeping its capacity
+            tasks.clear();
+            head = 0;
+        }
+        return task;
+    }
+
+private:
+    std::vector<Task> tasks;
+    // Index of the next task to pop
+    size_t head = 0;
+};
 
 // Custom implementation of a thread pool. Enqueue tasks on the queue to get
 // one of the worker threads to run it.
+//
+// Tasks are small fixed-size objects, called with the index of the worker
+// running them so that they can use scratch space owned by that worker.
+//
+// Tasks are queued on lanes, and the worker threads take tasks from the lanes in
+// turn. Giving each independent job its own lane keeps a job that floods the
+// pool with tasks from starving the others.
+template<typename Task>
 class ThreadPool {
 public:
-    explicit ThreadPool(size_t numThreads) : stop(false), tasks_busy(0) {
+    explicit ThreadPool(size_t numThreads) : lanes(1), next_lane(0), tasks_queued(0), tasks_busy(0), stop(false) {
         for (size_t i = 0; i < numThreads; ++i) {
             // Add a worker thread
-            workers.emplace_back([this] {
+            workers.emplace_back([this, i] {
+                // Taking tasks off the queue and running them is counted, so that checking the
+                // search for allocations covers the pool as well
+                CountAllocations count_allocations;
                 while (true) {
-                    std::function<void()> task;
+                    Task task;
                     {
                         std::unique_lock<std::mutex> lock(queueMutex);
-                        task_condition.wait(lock, [this] { return stop || !tasks.empty(); });
+                        task_condition.wait(lock, [this] { return stop || tasks_queued > 0; });
                         // If the threads have been explicitly stopped or the queue is empty
                         // then kill the worker thread
-                        if (stop && tasks.empty()) {
+                        if (stop && tasks_queued == 0) {
                             return;
                         }
-                        task = std::move(tasks.front());
-                        tasks.pop();
+                        // Take the task from the next non-empty lane, round-robin
+                        while (lanes[next_lane].empty()) {
+                            next_lane = (next_lane + 1) % lanes.size();
+                        }
+                        task = lanes[next_lane].pop();
+                        next_lane = (next_lane + 1) % lanes.size();
+                        tasks_queued--;
                         tasks_busy++;
 
                         lock.unlock();
                         try {
                             // Run the task here
-                            task();
+                            task(i);
                         } catch (const std::exception& e) {
                             std::cout << "Exception in thread: " << e.what() << std::endl;
                         } catch (...) {
@@ -46,9 +100,27 @@ public:
         std::cout << "Done creating " << numThreads << " workers" << std::endl;
     }
 
-    // Enqueue a task onto the queue for the worker threads to run
-    template<class F>
-    void enqueue(F&& task) {
+    size_t size() const {
+        return workers.size();
+    }
+
+    // Make room for the given number of tasks on a lane, so that enqueueing them
+    // doesn't allocate
+    void reserve(size_t lane, size_t capacity) {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        if (lane >= lanes.size()) {
+            lanes.resize(lane + 1);
+        }
+        lanes[lane].reserve(capacity);
+    }
+
+    // Enqueue a task onto the first lane for the worker threads to run
+    void enqueue(const Task &task) {
+        enqueue(0, task);
+    }
+
+    // Enqueue a task onto the given lane for the worker threads to run
+    void enqueue(size_t lane, const Task &task) {
         // Add the task to the queue - but first wait to acquire the queue lock
         {
             std::lock_guard<std::mutex> lock(queueMutex);
@@ -56,7 +128,11 @@ public:
                 std::cout << "Enqueue on stopped ThreadPool" << std::endl;
                 throw std::runtime_error("enqueue on stopped ThreadPool");
             }
-            tasks.emplace(std::forward<F>(task));
+            if (lane >= lanes.size()) {
+                lanes.resize(lane + 1);
+            }
+            lanes[lane].push(task);
+            tasks_queued++;
         }
         // Notify one of the worker threads to wake up and run one of the tasks from
         // the queue
@@ -67,7 +143,7 @@ public:
     void wait_finished() {
         std::unique_lock<std::mutex> lock(queueMutex);
         std::cout << "Waiting for ThreadPool to finish" << std::endl;
-        pool_finished_condition.wait(lock, [this] { return tasks.empty() && tasks_busy == 0; });
+        pool_finished_condition.wait(lock, [this] { return tasks_queued == 0 && tasks_busy == 0; });
         std::cout << "ThreadPool finished" << std::endl;
     }
 
@@ -86,8 +162,12 @@ public:
 private:
     // Collection of worker threads
     std::vector<std::thread> workers;
-    // Collection of tasks enqueued for the worker threads to run
-    std::queue<std::function<void()>> tasks;
+    // Collection of tasks enqueued for the worker threads to run, one queue per lane
+    std::vector<TaskSlab<Task>> lanes;
+    // Lane to take the next task from
+    size_t next_lane;
+    // Number of tasks enqueued across all lanes
+    size_t tasks_queued;
     // Mutex to access the queue
     std::mutex queueMutex;
     // Set when a task is enqueued